@@ -0,0 +1,84 @@
+/*
+   This sketch shows how to record the I2C bus transactions made by the library.
+   Here you will see how to keep a trace in RAM and send it to a computer for analysis.
+
+   Arduino and MIC74 setup
+
+   | Arduino  |  MIC74   | Description |
+   | -------- | -------- | ----------- |
+   |    A5    | CLK (14) | I2C Clock   |
+   |    A4    | DAT (15) | I2C Data    |
+   | -------- | -------- | ----------- |
+   |   LEDs:  |          |             |
+   |   LED1   |  P4 (9)  |  output     |
+   |   LED2   |  P5 (10) |  output     |
+   |   LED3   |  P6 (11) |  output     |
+   |   LED4   |  P7 (12) |  output     |
+
+   See schematic on https://github.com/TarAndr/AnTar_MIC74/blob/main/extras/images/MIC74_LEDs.GIF
+
+   Instructions:
+   After starting, the connected LEDs will light up in turn, and also turn off in turn.
+   Every register read and write is recorded in a RAM ring, the oldest records are dropped when it is full.
+   Send any character through the serial port to receive the binary trace, for example on Linux:
+     stty -F /dev/ttyUSB0 9600 raw && (echo > /dev/ttyUSB0; timeout 2 cat /dev/ttyUSB0 > trace.bin)
+   Then analyze it on the computer with extras/tools/mic74_replay:
+     mic74_replay trace.bin
+
+   Author: Andrey Tarasenko.
+*/
+
+#include <AnTar_mic74.h>
+
+// constants won't change. They're used here to set pin numbers:
+// led pin numbers
+const int ledPin1 = 4;
+const int ledPin2 = 5;
+const int ledPin3 = 6;
+const int ledPin4 = 7;
+
+// variables will change:
+bool activeState = LOW;
+
+uint8_t traceBuffer[256];  // RAM ring for the bus trace
+
+MIC74 mic;  // Creating a MIC object
+
+void setup() {
+  Serial.begin(9600); // The baudrate of Serial monitor is set in 9600
+  while (!Serial); // Waiting for Serial Monitor
+
+  mic.begin();  // Starting the device with default settings
+  mic.traceBegin(traceBuffer, sizeof(traceBuffer));  // Recording of the bus transactions to RAM
+  //mic.traceBegin(Serial);  // Or streaming them directly to a serial port that is not used for text
+
+  // turn off all LEDs
+  mic.digitalWrite(ledPin1, !activeState);
+  mic.digitalWrite(ledPin2, !activeState);
+  mic.digitalWrite(ledPin3, !activeState);
+  mic.digitalWrite(ledPin4, !activeState);
+
+  // initialize the led pins as an output:
+  mic.pinMode(ledPin1, OUTPUT);
+  mic.pinMode(ledPin2, OUTPUT);
+  mic.pinMode(ledPin3, OUTPUT);
+  mic.pinMode(ledPin4, OUTPUT);
+}
+
+void loop() {
+
+  for(int i = ledPin1; i <= ledPin4; ++i) {
+    // write the state of the led value:
+    mic.digitalWrite(i, activeState);
+
+    // send the trace when requested:
+    if(Serial.available()) {
+      while(Serial.available()) Serial.read();
+      mic.traceDump(Serial);
+    }
+
+    delay(400);
+  }
+
+  activeState = !activeState;
+}
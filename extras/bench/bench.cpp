@@ -0,0 +1,165 @@
+/*
+   Benchmark firmware for the MIC74 library hot paths (ATmega328P).
+
+   Every public API is called once with Timer1 counting CPU cycles and the
+   free RAM painted, then one line is sent through USART0:
+
+     BENCH <name> <cycles> <stack bytes>
+
+   The Wire library is replaced by the stand-in in stub/Wire.cpp, so the cycles
+   are those spent in the MIC74 driver; the real Wire/TWI path is not measured.
+   Built and run under simavr by the Makefile in this folder.
+
+   Author: Andrey Tarasenko.
+*/
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <stdlib.h>
+#include <AnTar_mic74.h>
+
+#define BAUD 115200
+#define STACK_PAINT 0xA5
+
+extern uint8_t __heap_start;
+
+typedef MIC74Field<2, 5, 6> MuxSelect;
+typedef MIC74Field<0, 1, 2, 3> Digit;
+
+MIC74 mic;
+uint8_t traceBuffer[64];
+
+volatile uint8_t sink;				// Keeps the results of inline helpers alive
+volatile uint8_t input = 0x5A;		// Keeps the arguments of inline helpers unknown
+uint16_t overhead;					// Cycles of an empty measurement
+
+// Advances by a fixed step per call, so trace deltas and their varint length do not depend on the Timer1 phase
+unsigned long micros()
+{
+    static unsigned long now = 0;
+    return now += 100;
+}
+
+static void uartPut(char c)
+{
+    while(!(UCSR0A & (1 << UDRE0)));
+    UDR0 = c;
+}
+
+static void uartPrint(const char *s)
+{
+    while(*s) uartPut(*s++);
+}
+
+static void uartPrintNumber(uint16_t value)
+{
+    char buf[6];
+    uartPrint(utoa(value, buf, 10));
+}
+
+// Both are inlined so that no return address lands in the painted area
+static inline void paintStack(uint8_t *sp) __attribute__((always_inline));
+static inline void paintStack(uint8_t *sp)
+{
+    uint8_t *p = &__heap_start;
+    while(p <= sp) *p++ = STACK_PAINT;
+}
+
+static inline uint16_t stackUsed(uint8_t *sp) __attribute__((always_inline));
+static inline uint16_t stackUsed(uint8_t *sp)
+{
+    uint8_t *p = &__heap_start;
+    while(p <= sp && *p == STACK_PAINT) ++p;
+    return sp + 1 - p;
+}
+
+static void report(const char *name, uint16_t cycles, uint16_t stack)
+{
+    uartPrint("BENCH ");
+    uartPrint(name);
+    uartPut(' ');
+    uartPrintNumber(cycles - overhead);
+    uartPut(' ');
+    uartPrintNumber(stack);
+    uartPrint("\r\n");
+}
+
+// Measures one statement, the SP is taken before painting so the paint loop itself is not counted
+#define BENCH(name, statement) do { \
+    uint8_t *sp = (uint8_t *) SP; \
+    paintStack(sp); \
+    uint16_t start = TCNT1; \
+    statement; \
+    uint16_t cycles = TCNT1 - start; \
+    report(name, cycles, stackUsed(sp)); \
+} while(0)
+
+int main()
+{
+    cli();
+    UBRR0 = F_CPU / 8 / BAUD - 1;
+    UCSR0A = 1 << U2X0;
+    UCSR0B = 1 << TXEN0;
+    TCCR1A = 0;
+    TCCR1B = 1 << CS10;				// Timer1 counts CPU cycles
+
+    uint16_t start = TCNT1;
+    uint16_t stop = TCNT1;
+    overhead = stop - start;
+
+    BENCH("begin", mic.begin());
+    BENCH("pinMode_INPUT", mic.pinMode(3, INPUT));
+    BENCH("pinMode_OUTPUT", mic.pinMode(4, OUTPUT));
+    BENCH("pinMode_INPUT_WITH_INTERRUPT", mic.pinMode(3, INPUT_WITH_INTERRUPT));
+    BENCH("pinMode_OUTPUT_PUSHPULL", mic.pinMode(4, OUTPUT_PUSHPULL));
+    BENCH("switchPinMode_OUTPUT", mic.switchPinMode(6, OUTPUT, LOW));
+    BENCH("switchPinMode_PUSHPULL", mic.switchPinMode(6, OUTPUT_PUSHPULL));
+    BENCH("switchPinMode_INPUT", mic.switchPinMode(6, INPUT));
+    BENCH("pinDriveLow", mic.pinDriveLow(6));
+    BENCH("pinRelease", mic.pinRelease(6));
+    BENCH("digitalWrite", mic.digitalWrite(4, HIGH));
+    BENCH("digitalWriteDelayed", mic.digitalWriteDelayed(4, LOW));
+    BENCH("digitalRead", sink = mic.digitalRead(3));
+    BENCH("pinToHigh", mic.pinToHigh(5));
+    BENCH("pinToLow", mic.pinToLow(5));
+    BENCH("pinToHighDelayed", mic.pinToHighDelayed(5));
+    BENCH("pinToLowDelayed", mic.pinToLowDelayed(5));
+    BENCH("portRead", sink = mic.portRead());
+    BENCH("portWrite", mic.portWrite());
+    BENCH("portWrite_value", mic.portWrite(0x0F));
+    BENCH("portWrite_mask", mic.portWrite(0x0F, 0x3C));
+    BENCH("fieldWrite_MuxSelect", mic.fieldWrite<MuxSelect>(5));
+    BENCH("fieldWrite_Digit", mic.fieldWrite<Digit>(9));
+    BENCH("fieldRead_Digit", sink = mic.fieldRead<Digit>());
+    BENCH("writePortMode", mic.writePortMode(0xF0));
+    BENCH("readPortMode", sink = mic.readPortMode());
+    BENCH("pushPullPinOn", mic.pushPullPinOn(6));
+    BENCH("pushPullPinOff", mic.pushPullPinOff(6));
+    BENCH("interruptPinOn", mic.interruptPinOn(2));
+    BENCH("interruptPinOff", mic.interruptPinOff(2));
+    BENCH("setup", mic.setup(ON, OFF));
+    BENCH("setInterrupts", mic.setInterrupts(OFF));
+    BENCH("fanMode", mic.fanMode(OFF));
+    BENCH("readStatus", sink = mic.readStatus());
+    BENCH("writeFanSpeed", mic.writeFanSpeed(3));
+    BENCH("readFanSpeed", sink = mic.readFanSpeed());
+    BENCH("isBitSet", sink = mic.isBitSet(input, 3));
+    BENCH("bitToSet", sink = mic.bitToSet(input, 3));
+    BENCH("bitToClr", sink = mic.bitToClr(input, 3));
+    BENCH("IS_BIT_SET", sink = IS_BIT_SET(input, 3) != 0);
+
+    mic.traceBegin(traceBuffer, sizeof(traceBuffer));
+    BENCH("digitalWrite_trace", mic.digitalWrite(4, HIGH));
+    for(uint8_t i = 0; i < 32; ++i) mic.digitalWrite(4, i & 1);	// Fills the ring so records get dropped
+    BENCH("digitalWrite_traceFull", mic.digitalWrite(4, LOW));
+    mic.traceEnd();
+
+    UCSR0A |= 1 << TXC0;			// Clears the transmit complete flag
+    uartPrint("BENCH_END\r\n");
+    while(!(UCSR0A & (1 << TXC0)));	// Waits for the last character to leave
+
+    set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+    sleep_mode();					// simavr quits on sleep with interrupts disabled
+    return 0;
+}
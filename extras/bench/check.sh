@@ -0,0 +1,27 @@
+#!/bin/sh
+# Compares benchmark results with the baseline and fails on any regression.
+# usage: check.sh base_results.txt results.txt
+# TOLERANCE (percent, default 0) allows a value to grow that much before failing.
+
+base=$1
+res=$2
+
+if [ ! -f "$base" ]; then
+    echo "check.sh: $base not found" >&2
+    exit 1
+fi
+
+awk -v tol="${TOLERANCE:-0}" '
+    BEGIN { col[2] = "cycles"; col[3] = "stack"; col[4] = "flash" }
+    /^#/ { next }
+    NR == FNR { for(i = 2; i <= 4; ++i) b[$1, i] = $i; known[$1] = 1; next }
+    {
+        if(!($1 in known)) { print "new      " $1; next }
+        for(i = 2; i <= 4; ++i) {
+            if($i == "-" || b[$1, i] == "-") continue
+            if($i + 0 > b[$1, i] * (1 + tol / 100)) { print "WORSE    " $1 " " col[i] ": " b[$1, i] " -> " $i; bad = 1 }
+            else if($i + 0 < b[$1, i] + 0) print "better   " $1 " " col[i] ": " b[$1, i] " -> " $i
+        }
+    }
+    END { if(bad) { print "check.sh: regressions found"; exit 1 } print "check.sh: no regressions" }
+' "$base" "$res"
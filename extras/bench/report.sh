@@ -0,0 +1,35 @@
+#!/bin/sh
+# Builds the benchmark table from the simavr output and the firmware symbols.
+# usage: report.sh run.txt bench.elf
+#
+# Columns: name, CPU cycles, stack bytes, flash bytes of the MIC74 method ("-" if inlined).
+# The "image" row holds the static RAM (.data + .bss) in the stack column and the whole firmware size in the flash column.
+
+run=$1
+elf=$2
+NM=${NM:-avr-nm}
+SIZE=${SIZE:-avr-size}
+
+if ! grep -q 'BENCH_END' "$run"; then
+    echo "report.sh: the benchmark did not finish, see $run" >&2
+    exit 1
+fi
+
+symbols=$($NM -C --print-size "$elf") || exit 1
+
+printf '# %-30s %8s %8s %8s\n' name cycles stack flash
+grep -o 'BENCH [^ ]* [0-9]* [0-9]*' "$run" | while read tag name cycles stack; do
+    method=${name%%_*}
+    flash=$(echo "$symbols" | awk -v m="MIC74::$method" '
+        function hex(s,   i, n) { n = 0; s = tolower(s); for(i = 1; i <= length(s); ++i) n = n * 16 + index("0123456789abcdef", substr(s, i, 1)) - 1; return n }
+        NF >= 4 && length($3) == 1 {
+            sym = $0; sub(/^[^ ]+ [^ ]+ [^ ]+ /, "", sym)
+            if(index(sym, m "(") == 1 || index(sym, m "<") == 1) total += hex($2)
+        }
+        END { if(total) print total; else print "-" }')
+    printf '%-32s %8s %8s %8s\n' "$name" "$cycles" "$stack" "$flash"
+done
+
+$SIZE -A "$elf" | awk '
+    $1 == ".text" { text = $2 } $1 == ".data" { data = $2 } $1 == ".bss" { bss = $2 }
+    END { printf "%-32s %8s %8s %8s\n", "image", "-", data + bss, text + data }'
@@ -0,0 +1,35 @@
+/*
+   Minimal Arduino core stand-in for the benchmark firmware.
+   Only what the library uses is provided, so the measured code is the driver itself.
+*/
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define HIGH 0x1
+#define LOW 0x0
+
+unsigned long micros();
+
+class Print
+{
+public:
+   virtual size_t write(uint8_t) = 0;
+   virtual size_t write(const uint8_t *buffer, size_t size)
+   {
+      size_t n = 0;
+      while(size--) n += this->write(*buffer++);
+      return n;
+   };
+};
+
+#endif
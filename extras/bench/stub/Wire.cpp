@@ -0,0 +1,57 @@
+#include "Wire.h"
+
+#define MIC74_ADDR 0x27
+#define MIC74_REG_STATUS 0x03
+#define MIC74_REG_DATA 0x05
+
+TwoWire Wire;
+
+TwoWire::TwoWire()
+{
+   for(uint8_t i = 0; i < sizeof(this->_regs); ++i) this->_regs[i] = 0x00;
+   this->_regs[MIC74_REG_DATA] = 0xFF;		// Power-on default value
+   this->_address = this->_pointer = this->_txCount = 0;
+   this->_rxByte = -1;
+}
+
+void TwoWire::begin()
+{
+}
+
+void TwoWire::setClock(uint32_t clock)
+{
+   (void) clock;
+}
+
+void TwoWire::beginTransmission(int address)
+{
+   this->_address = address;
+   this->_txCount = 0;
+}
+
+size_t TwoWire::write(uint8_t data)
+{
+   if(this->_txCount++ == 0) this->_pointer = data & 0x07;
+   else this->_regs[this->_pointer] = data;
+   return 1;
+}
+
+uint8_t TwoWire::endTransmission()
+{
+   return this->_address == MIC74_ADDR ? 0 : 2;	// 2 = NACK on address
+}
+
+uint8_t TwoWire::requestFrom(int address, int quantity)
+{
+   if(address != MIC74_ADDR || quantity < 1) return 0;
+   this->_rxByte = this->_regs[this->_pointer];
+   if(this->_pointer == MIC74_REG_STATUS) this->_regs[MIC74_REG_STATUS] = 0x00;	// Reading clears STATUS
+   return 1;
+}
+
+int TwoWire::read()
+{
+   int value = this->_rxByte;
+   this->_rxByte = -1;
+   return value;
+}
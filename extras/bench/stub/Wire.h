@@ -0,0 +1,33 @@
+/*
+   Wire library stand-in for the benchmark firmware.
+   Replaces the Arduino Wire library and answers from an emulated MIC74 register file at DEF_I2C_ADDR.
+   Neither the real Wire code nor the TWI peripheral is used, so their cycles and the bus time are not measured.
+*/
+
+#ifndef TwoWire_h
+#define TwoWire_h
+
+#include <Arduino.h>
+
+class TwoWire
+{
+   uint8_t _regs[8];		// Emulated MIC74 registers
+   uint8_t _address;		// Address of the current transaction
+   uint8_t _pointer;		// Register pointer
+   uint8_t _txCount;		// Bytes written in the current transaction
+   int _rxByte;				// Byte returned by the next read(), -1 = none
+
+public:
+   TwoWire();
+   void begin();
+   void setClock(uint32_t clock);
+   void beginTransmission(int address);
+   uint8_t endTransmission();
+   uint8_t requestFrom(int address, int quantity);
+   size_t write(uint8_t data);
+   int read();
+};
+
+extern TwoWire Wire;
+
+#endif
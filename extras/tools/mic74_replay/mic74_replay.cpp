@@ -0,0 +1,231 @@
+/*
+   MIC74 bus trace replay analyzer (host side).
+
+   Feeds a trace recorded with MIC74::traceBegin() / traceDump() back through
+   a simulated MIC74 and reports redundant writes, read-modify-write pairs and
+   bus utilization over time.
+
+   Build:
+     g++ -O2 -o mic74_replay mic74_replay.cpp
+
+   Usage:
+     mic74_replay trace.bin [-c i2cFrequency] [-w windowMs]
+
+     -c  I2C bus frequency in Hertz used to estimate bus time (default 100000)
+     -w  Utilization window in milliseconds (default 100)
+
+   The record layout is described next to TRACE_REC_MAX in src/AnTar_mic74.h.
+   Time deltas are 32-bit microseconds, so an idle gap longer than about
+   71.6 minutes between two records is shown shorter than it was.
+
+   Author: Andrey Tarasenko.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <map>
+
+#define REG_COUNT 7
+#define REG_STATUS 0x03
+#define REG_DATA 0x05
+#define TRACE_NO_DATA 0x10		// Status of a read that received no data byte
+
+// Bit times of one transaction: START, bytes with ACK, repeated START, STOP
+#define WRITE_BITS (1 + 3 * 9 + 1)			// addr+W, reg, value
+#define READ_BITS (1 + 2 * 9 + 1 + 2 * 9 + 1)	// addr+W, reg, STOP / START, addr+R, value
+
+static const char *regName[REG_COUNT + 1] = {
+    "DEV_CFG", "DIR", "OUT_CFG", "STATUS", "INT_MASK", "DATA", "FAN_SPEED", "0x07"
+};
+
+struct Record
+{
+    uint8_t write;		// 1 = regWrite(), 0 = regRead()
+    uint8_t reg;
+    uint8_t addr;		// 0x20 ~ 0x27
+    uint8_t status;		// Wire endTransmission() result or TRACE_NO_DATA
+    uint8_t value;
+    uint64_t time;		// Microseconds since the first record
+};
+
+// Simulated MIC74: what the driver could have known about each register
+struct Device
+{
+    uint8_t reg[REG_COUNT + 1];
+    bool known[REG_COUNT + 1];
+};
+
+// Transactions and estimated bus time of one utilization window
+struct Window
+{
+    unsigned long transactions;
+    double busyUs;
+};
+
+struct Counters
+{
+    unsigned long reads, writes, redundant, rmw, rmwAvoidable;
+};
+
+static bool decode(const std::vector<uint8_t> &buf, std::vector<Record> &out)
+{
+    size_t pos = 0;
+    uint64_t time = 0;
+    while(pos < buf.size())
+    {
+        Record rec;
+        uint8_t hdr = buf[pos++];
+        rec.write = hdr >> 7;
+        rec.reg = (hdr >> 4) & 0x07;
+        rec.addr = 0x20 | ((hdr >> 1) & 0x07);
+        rec.status = 0;
+        if(hdr & 0x01)
+        {
+            if(pos >= buf.size()) return false;
+            rec.status = buf[pos++];
+        }
+        uint64_t delta = 0;
+        for(int shift = 0; ; shift += 7)
+        {
+            if(pos >= buf.size() || shift > 63) return false;
+            uint8_t b = buf[pos++];
+            delta |= (uint64_t)(b & 0x7F) << shift;
+            if(!(b & 0x80)) break;
+        }
+        if(pos >= buf.size()) return false;
+        rec.value = buf[pos++];
+        time += out.empty() ? 0 : delta;	// The first delta refers to a record that is not in the trace
+        rec.time = time;
+        out.push_back(rec);
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = NULL;
+    double i2cFrequency = 100000;
+    double windowMs = 100;
+    bool usage = false;
+
+    for(int i = 1; i < argc && !usage; ++i)
+    {
+        if(!strcmp(argv[i], "-c") && i + 1 < argc) i2cFrequency = atof(argv[++i]);
+        else if(!strcmp(argv[i], "-w") && i + 1 < argc) windowMs = atof(argv[++i]);
+        else if(argv[i][0] != '-' && !path) path = argv[i];
+        else usage = true;
+    }
+    if(usage || !path || i2cFrequency <= 0 || windowMs < 0.001)
+    {
+        fprintf(stderr, "usage: %s trace.bin [-c i2cFrequency] [-w windowMs]\n", argv[0]);
+        return 2;
+    }
+
+    FILE *f = fopen(path, "rb");
+    if(!f)
+    {
+        perror(path);
+        return 1;
+    }
+    std::vector<uint8_t> buf;
+    int c;
+    while((c = fgetc(f)) != EOF) buf.push_back((uint8_t) c);
+    fclose(f);
+
+    std::vector<Record> recs;
+    if(!decode(buf, recs)) fprintf(stderr, "warning: trace ends with a truncated record\n");
+    if(recs.empty())
+    {
+        printf("No records.\n");
+        return 0;
+    }
+
+    Device dev[8];
+    memset(dev, 0, sizeof(dev));
+    Counters reg[REG_COUNT + 1];
+    memset(reg, 0, sizeof(reg));
+    unsigned long failed = 0, noData = 0;
+
+    double bitUs = 1e6 / i2cFrequency;
+    uint64_t windowUs = (uint64_t)(windowMs * 1000);
+    std::map<uint64_t, Window> windows;		// Only the windows that have transactions
+
+    bool predictable = false;	// The previous read returned a value the driver already knew
+    for(size_t i = 0; i < recs.size(); ++i)
+    {
+        const Record &r = recs[i];
+        Device &d = dev[r.addr & 0x07];
+        Counters &n = reg[r.reg];
+
+        Window &w = windows[r.time / windowUs];
+        w.busyUs += (r.write ? WRITE_BITS : READ_BITS) * bitUs;
+        ++w.transactions;
+
+        if(r.status != 0)
+        {
+            if(r.status == TRACE_NO_DATA) ++noData;
+            else ++failed;
+            predictable = false;
+            continue;
+        }
+
+        if(r.write)
+        {
+            ++n.writes;
+            if(d.known[r.reg] && d.reg[r.reg] == r.value) ++n.redundant;
+            // A read of the same register just before this write, with nothing in between
+            const Record *p = i > 0 ? &recs[i - 1] : NULL;
+            if(p && !p->write && p->status == 0 && p->addr == r.addr && p->reg == r.reg)
+            {
+                ++n.rmw;
+                if(predictable) ++n.rmwAvoidable;
+            }
+            d.reg[r.reg] = r.value;
+            d.known[r.reg] = true;
+            predictable = false;
+        }
+        else
+        {
+            ++n.reads;
+            // Reading clears STATUS and input pins make DATA reads unrelated to the last write
+            predictable = r.reg != REG_STATUS && r.reg != REG_DATA && d.known[r.reg] && d.reg[r.reg] == r.value;
+            if(r.reg == REG_STATUS) d.known[r.reg] = false;
+            else if(r.reg != REG_DATA)
+            {
+                d.reg[r.reg] = r.value;
+                d.known[r.reg] = true;
+            }
+        }
+    }
+
+    double spanMs = recs.back().time / 1000.0;
+    printf("Records: %lu  span: %.3f ms  bus errors: %lu  reads without data: %lu\n\n", (unsigned long) recs.size(), spanMs, failed, noData);
+
+    printf("%-10s %8s %8s %10s %8s %10s\n", "register", "reads", "writes", "redundant", "rmw", "avoidable");
+    Counters total;
+    memset(&total, 0, sizeof(total));
+    for(int r = 0; r <= REG_COUNT; ++r)
+    {
+        const Counters &n = reg[r];
+        if(!n.reads && !n.writes) continue;
+        printf("%-10s %8lu %8lu %10lu %8lu %10lu\n", regName[r], n.reads, n.writes, n.redundant, n.rmw, n.rmwAvoidable);
+        total.reads += n.reads;
+        total.writes += n.writes;
+        total.redundant += n.redundant;
+        total.rmw += n.rmw;
+        total.rmwAvoidable += n.rmwAvoidable;
+    }
+    printf("%-10s %8lu %8lu %10lu %8lu %10lu\n\n", "total", total.reads, total.writes, total.redundant, total.rmw, total.rmwAvoidable);
+    printf("redundant: writes of the value the register already held\n");
+    printf("rmw:       reads immediately followed by a write of the same register\n");
+    printf("avoidable: rmw pairs whose read could have been served from a shadow register\n\n");
+
+    printf("Bus utilization at %.0f Hz, %g ms windows:\n", i2cFrequency, windowMs);
+    printf("%10s %8s %8s\n", "start ms", "trans", "busy %");
+    for(std::map<uint64_t, Window>::const_iterator w = windows.begin(); w != windows.end(); ++w)
+        printf("%10.3f %8lu %8.2f\n", w->first * windowMs, w->second.transactions, 100.0 * w->second.busyUs / windowUs);
+    return 0;
+}
@@ -46,13 +46,31 @@ uint8_t MIC74::lookFor() {
 /**
  * @ingroup group01
  * @brief Starts the MIC74 
- * @details Starts the MIC74 with default values.
+ * @details Starts the MIC74 with default values and reads its current configuration into the shadow registers,
+ * @details so the chip keeps its state when only the Arduino was reset.
  */
 void MIC74::begin(uint8_t i2cAddress, long i2cFrequency)
 {
     Wire.begin(); 						//creates a Wire object
 	Wire.setClock(i2cFrequency);
     this->_i2cAddress = i2cAddress;
+    this->syncShadows();
+}
+
+/**
+ * @ingroup group01
+ * @brief Reads the MIC74 configuration into the shadow registers
+ * @details Reads DIR, OUT_CFG, INT_MASK and DATA. Called by begin(); call it again if the chip may have been changed elsewhere.
+ * @details Reading DATA returns the output latch of output pins only, so the latch of input pins is treated as unknown.
+ */
+void MIC74::syncShadows()
+{
+    this->readPortMode();
+    this->readPortOutMode();
+    this->readPortInterrupts();
+    uint8_t data = this->portRead();
+    this->_latchLow = ~data & this->_dir;
+    this->_latchMayLow = ~data | ~this->_dir;
 }
 
 /**
@@ -93,9 +111,11 @@ void MIC74::begin(uint8_t i2cAddress, long i2cFrequency)
 uint8_t MIC74::regRead(uint8_t reg) {
     Wire.beginTransmission(this->_i2cAddress);
     Wire.write(reg);
-    Wire.endTransmission();
-    Wire.requestFrom((int) this->_i2cAddress, (int) 1);
-    return Wire.read();
+    uint8_t status = Wire.endTransmission();
+    if(Wire.requestFrom((int) this->_i2cAddress, (int) 1) != 1 && status == 0) status = TRACE_NO_DATA;
+    uint8_t value = Wire.read();
+    if(this->_traceBuf || this->_traceOut) this->traceRecord(reg, value, TRACE_READ, status);
+    return value;
 }
 
 /**
@@ -116,17 +136,139 @@ void MIC74::pinMode(uint8_t pin, uint8_t mode)
 	if(mode == INPUT || mode == INPUT_WITH_INTERRUPT)
 	{
 		another_mask = this->regRead(REG_INT_MASK) & ~(1 << pin) | (another_mask << pin);
-		this->regWrite(REG_INT_MASK, another_mask);
+		this->writePortInterrupts(another_mask);
 	}
 	else if(mode == OUTPUT || mode == OUTPUT_PUSHPULL)
 	{
 		dir_mask = 1;
 		another_mask = this->regRead(REG_OUT_CFG) & ~(1 << pin) | (another_mask << pin);
-		this->regWrite(REG_OUT_CFG, another_mask);
+		this->writePortOutMode(another_mask);
 	}
 
 	dir_mask = this->regRead(REG_DIR) & ~(1 << pin) | (dir_mask << pin);
-    this->regWrite(REG_DIR, dir_mask);
+    this->writePortMode(dir_mask);
+}
+
+/**
+ * @ingroup group02
+ * @brief Changes the mode of a given GPIO pin, keeping its output level
+ * @details Like switchPinMode(pin, mode, value), with the level taken from the chip: an output keeps its current level,
+ * @details an input becomes an output at the level held in its DATA latch when that is known to be low, otherwise HIGH (the power-on level).
+ * @param pin the GPIO PIN number (0-7)
+ * @param mode INPUT, OUTPUT, INPUT_WITH_INTERRUPT or OUTPUT_PUSHPULL
+ */
+void MIC74::switchPinMode(uint8_t pin, uint8_t mode)
+{
+    if(pin > 7) return;
+
+	uint8_t bit = 1 << pin;
+	uint8_t low = (this->_dir & bit) ? !(this->_data & bit) : (this->_latchLow & bit);
+	this->switchPinMode(pin, mode, low ? LOW : HIGH);
+}
+
+/**
+ * @ingroup group02
+ * @brief Changes the mode of a given GPIO pin from the shadow registers
+ * @details Computes DATA, OUT_CFG, DIR and INT_MASK from the shadow registers and writes only the registers that change.
+ * @details When an input becomes an output and its latch is known to hold the requested level, only OUT_CFG and DIR are written.
+ * @details Otherwise DATA is written first, but the datasheet states that DATA writes to input pins are ignored,
+ * @details so the pin is turned with an open-drain stage, DATA is written again once it is an output, and only then the push-pull stage is selected.
+ * @details When an output changes its level and output stage together, OUT_CFG is written first if push-pull is cleared and last if it is set.
+ * @details This is glitch-free, with one exception: a HIGH request for a pin whose latch may hold 0 (it was last driven low,
+ * @details or its state is unknown after begin()) drives a short low pulse before the second DATA write, if the chip ignores the first one.
+ * @details When an output becomes an input, DIR is written first, so it stops driving before its interrupt is armed.
+ * @param pin the GPIO PIN number (0-7)
+ * @param mode INPUT, OUTPUT, INPUT_WITH_INTERRUPT or OUTPUT_PUSHPULL
+ * @param value level of an output pin: 1 = High; 0 = Low; or HIGH and LOW
+ */
+void MIC74::switchPinMode(uint8_t pin, uint8_t mode, uint8_t value)
+{
+    if(pin > 7) return;
+
+	uint8_t bit = 1 << pin;
+	uint8_t dir = this->_dir, outCfg = this->_outCfg, intMask = this->_intMask, data = this->_data;
+
+	if(mode == OUTPUT || mode == OUTPUT_PUSHPULL)
+	{
+		dir |= bit;
+		outCfg = (mode == OUTPUT_PUSHPULL) ? (outCfg | bit) : (outCfg & ~bit);
+		intMask &= ~bit;
+		data = (value != LOW) ? (data | bit) : (data & ~bit);
+
+		if(intMask != this->_intMask) this->writePortInterrupts(intMask);
+
+		if(this->_dir & bit)	// Already an output: the level and the output stage change in place
+		{
+			// Leaving push-pull releases the line first, so a high level is never driven on the way to open-drain
+			if(!(outCfg & bit) && outCfg != this->_outCfg) this->writePortOutMode(outCfg);
+			if(data != this->_data) this->portWrite(data);
+			if(outCfg != this->_outCfg) this->writePortOutMode(outCfg);
+			return;
+		}
+
+		uint8_t unsure = (value != LOW) ? (this->_latchMayLow & bit) : (~this->_latchLow & bit);
+		if(unsure)
+		{
+			this->portWrite(data);	// Presets the latch, in case the chip takes DATA writes to input pins
+			// A stale high latch leaves an open-drain line released instead of driving it high
+			if(this->_outCfg & bit) this->writePortOutMode(this->_outCfg & ~bit);
+			this->writePortMode(dir);
+			this->portWrite(data);	// The pin is an output now, so this write is always taken
+		}
+		else
+		{
+			if(outCfg != this->_outCfg) this->writePortOutMode(outCfg);
+			this->writePortMode(dir);
+		}
+		if(outCfg != this->_outCfg) this->writePortOutMode(outCfg);
+	}
+	else if(mode == INPUT || mode == INPUT_WITH_INTERRUPT)
+	{
+		dir &= ~bit;
+		intMask = (mode == INPUT_WITH_INTERRUPT) ? (intMask | bit) : (intMask & ~bit);
+
+		if(dir != this->_dir) this->writePortMode(dir);
+		if(intMask != this->_intMask) this->writePortInterrupts(intMask);
+	}
+}
+
+/**
+ * @ingroup group02
+ * @brief Releases a given open-drain line
+ * @details Turns the pin to input with a single DIR write from the shadow register, so the line is pulled up externally.
+ * @details Prepare the pin once with switchPinMode(pin, OUTPUT, LOW), then use pinRelease() and pinDriveLow() for each line turnaround.
+ * @param pin the GPIO PIN number (0-7)
+ */
+void MIC74::pinRelease(uint8_t pin)
+{
+    if(pin > 7) return;
+    this->writePortMode(this->_dir & ~(1 << pin));
+}
+
+/**
+ * @ingroup group02
+ * @brief Drives a given open-drain line low
+ * @details Turns the pin to output with a single DIR write from the shadow register while its DATA latch is known to hold 0.
+ * @details A DATA write with this bit set (e.g. portWrite() or digitalWrite() of another pin while the line is released and reads high)
+ * @details makes the latch unknown; the next call then clears the bit in DATA before and after turning the pin, which costs two more writes.
+ * @details The pin must use the open-drain stage, so a stale high latch leaves the line released rather than driving it high.
+ * @param pin the GPIO PIN number (0-7)
+ */
+void MIC74::pinDriveLow(uint8_t pin)
+{
+    if(pin > 7) return;
+
+	uint8_t bit = 1 << pin;
+	if(this->_latchLow & bit)
+	{
+		if(!(this->_dir & bit)) this->writePortMode(this->_dir | bit);
+		return;
+	}
+
+	uint8_t data = this->_data & ~bit;
+	this->portWrite(data);		// Presets the latch, in case the chip takes DATA writes to input pins
+	if(!(this->_dir & bit)) this->writePortMode(this->_dir | bit);
+	if(!(this->_latchLow & bit)) this->portWrite(data);
 }
 
    /**
@@ -175,7 +317,13 @@ void MIC74::regWrite(uint8_t reg, uint8_t value) {
     Wire.beginTransmission(this->_i2cAddress);
     Wire.write(reg);
     Wire.write(value);
-    Wire.endTransmission(); //ends communication with the device
+    uint8_t status = Wire.endTransmission(); //ends communication with the device
+    if(reg == REG_DATA)	// Output pins always take the new level; input pins may ignore it, see switchPinMode()
+    {
+        this->_latchLow = ~value & (this->_dir | this->_latchLow);
+        this->_latchMayLow = ~value | (this->_latchMayLow & ~this->_dir);
+    }
+    if(this->_traceBuf || this->_traceOut) this->traceRecord(reg, value, TRACE_WRITE, status);
 }
 
    /**
@@ -190,6 +338,18 @@ void MIC74::regWrite(uint8_t reg, uint8_t value) {
 	   this->_data = value;
    }
 
+   /**
+   * @ingroup group02
+   * @brief Sets the masked bits of the GPIO Register
+   * @details Replaces the masked bits of the shadow register and writes it to the chip at once, without reading the port first.
+   * @param value (8 bits)
+   * @param mask bits to replace (1 = taken from value; 0 = kept from the shadow register)
+   */
+   void MIC74::portWrite(uint8_t value, uint8_t mask)
+   {
+       this->portWrite((this->_data & ~mask) | (value & mask));
+   }
+
    /**
    * @ingroup group02
    * @brief Sets a value to the DIR Register
@@ -199,6 +359,7 @@ void MIC74::regWrite(uint8_t reg, uint8_t value) {
    void MIC74::writePortMode(uint8_t value)
    {
        this->regWrite(REG_DIR, value);
+	   this->_dir = value;
    }
 
    /**
@@ -210,7 +371,8 @@ void MIC74::regWrite(uint8_t reg, uint8_t value) {
    */
    uint8_t MIC74::readPortMode()
    {
-       return this->regRead(REG_DIR);
+       this->_dir = this->regRead(REG_DIR);
+       return this->_dir;
    }
 
    /**
@@ -222,6 +384,7 @@ void MIC74::regWrite(uint8_t reg, uint8_t value) {
    void MIC74::writePortOutMode(uint8_t value)
    {
        this->regWrite(REG_OUT_CFG, value);
+	   this->_outCfg = value;
    }
 
    /**
@@ -233,7 +396,8 @@ void MIC74::regWrite(uint8_t reg, uint8_t value) {
    */
    uint8_t MIC74::readPortOutMode()
    {
-       return this->regRead(REG_OUT_CFG);
+       this->_outCfg = this->regRead(REG_OUT_CFG);
+       return this->_outCfg;
    }
 
    /**
@@ -245,6 +409,7 @@ void MIC74::regWrite(uint8_t reg, uint8_t value) {
    void MIC74::writePortInterrupts(uint8_t mask)
    {
        this->regWrite(REG_INT_MASK, mask);
+	   this->_intMask = mask;
    }
 
    /**
@@ -256,7 +421,8 @@ void MIC74::regWrite(uint8_t reg, uint8_t value) {
    */
    uint8_t MIC74::readPortInterrupts()
    {
-       return this->regRead(REG_INT_MASK);
+       this->_intMask = this->regRead(REG_INT_MASK);
+       return this->_intMask;
    }
 
    /**
@@ -418,7 +584,7 @@ void MIC74::pushPullPinOn(uint8_t pin)
     uint8_t gppp;
     gppp = this->regRead(REG_OUT_CFG); // Gets the current values of push-pull setup
     gppp |= 1 << pin;
-    this->regWrite(REG_OUT_CFG, gppp); // Updates the values of push-pull setup
+    this->writePortOutMode(gppp); // Updates the values of push-pull setup
 }
 
 /**
@@ -434,7 +600,7 @@ void MIC74::pushPullPinOff(uint8_t pin)
     uint8_t gppp;
     gppp = this->regRead(REG_OUT_CFG); // Gets the current values of push-pull setup
     gppp &= ~(1 << pin);
-    this->regWrite(REG_OUT_CFG, gppp); // Updates the values of push-pull setup
+    this->writePortOutMode(gppp); // Updates the values of push-pull setup
 }
 
 /**
@@ -502,7 +668,7 @@ void MIC74::interruptPinOn(uint8_t pin)
     // Enables the GPIO pin to deal with interrupt  
     mask = this->regRead(REG_INT_MASK); // Gets the current values of REG_INT_MASK
 	mask |= 1 << pin;
-    this->regWrite(REG_INT_MASK, mask); // Updates the values of the REG_INT_MASK register
+    this->writePortInterrupts(mask); // Updates the values of the REG_INT_MASK register
 }
 
 /**
@@ -522,5 +688,139 @@ void MIC74::interruptPinOff(uint8_t pin)
     // Disables the GPIO pin to deal with interrupt  
     mask = this->regRead(REG_INT_MASK); // Gets the current values of REG_INT_MASK
 	mask &= ~(1 << pin);
-    this->regWrite(REG_INT_MASK, mask); // Updates the values of the REG_INT_MASK register
+    this->writePortInterrupts(mask); // Updates the values of the REG_INT_MASK register
+}
+
+/** @defgroup group03 MIC74 bus trace functions */
+
+/**
+ * @ingroup group03
+ * @brief Starts recording bus transactions to a RAM ring
+ * @details Every regRead() and regWrite() appends a compact record (see TRACE_REC_MAX) to the given buffer.
+ * @details When the buffer is full, the oldest records are dropped to make room for the new ones.
+ * @param buffer RAM owned by the caller, it must stay valid until traceEnd()
+ * @param size buffer size in bytes
+ */
+void MIC74::traceBegin(uint8_t *buffer, uint16_t size)
+{
+    this->_traceBuf = buffer;
+    this->_traceSize = size;
+    this->_traceHead = this->_traceTail = this->_traceUsed = 0;
+    this->_traceTime = micros();
+}
+
+/**
+ * @ingroup group03
+ * @brief Starts streaming bus transactions to a Print
+ * @details Every regRead() and regWrite() writes a compact binary record to the given stream.
+ * @details Use a stream that is not shared with text output, or the records will be mixed with it.
+ * @param out stream to write the records to (e.g. Serial)
+ */
+void MIC74::traceBegin(Print &out)
+{
+    this->_traceOut = &out;
+    this->_traceTime = micros();
+}
+
+/**
+ * @ingroup group03
+ * @brief Stops recording bus transactions
+ * @details Detaches both the RAM ring and the stream. The ring content is left in the caller's buffer.
+ */
+void MIC74::traceEnd()
+{
+    this->_traceBuf = NULL;
+    this->_traceOut = NULL;
+}
+
+/**
+ * @ingroup group03
+ * @brief Gets the number of bytes held in the trace ring
+ * @return uint16_t number of bytes traceDump() would write
+ */
+uint16_t MIC74::traceAvailable()
+{
+    return this->_traceUsed;
+}
+
+/**
+ * @ingroup group03
+ * @brief Writes the trace ring oldest first and empties it
+ * @details The output is a plain sequence of records which can be fed to extras/tools/mic74_replay.
+ * @param out stream to write the records to (e.g. Serial)
+ * @return uint16_t number of bytes written
+ */
+uint16_t MIC74::traceDump(Print &out)
+{
+    if(!this->_traceBuf) return 0;
+    uint16_t count = this->_traceUsed;
+    uint16_t first = this->_traceSize - this->_traceTail;	// Bytes up to the end of the ring
+    if(first > count) first = count;
+    out.write(this->_traceBuf + this->_traceTail, first);
+    out.write(this->_traceBuf, count - first);
+    this->_traceHead = this->_traceTail = this->_traceUsed = 0;
+    return count;
+}
+
+/**
+ * @ingroup group03
+ * @brief Gets the length of the ring record at a given offset
+ * @param pos ring offset of the record header
+ * @return uint8_t record length in bytes
+ */
+uint8_t MIC74::traceRecLen(uint16_t pos)
+{
+    uint8_t len = (this->_traceBuf[pos] & 0x01) ? 2 : 1;	// Header and optional status
+    pos += len;
+    if(pos >= this->_traceSize) pos -= this->_traceSize;
+    while(this->_traceBuf[pos] & 0x80)	// Delta continuation bytes
+    {
+        ++len;
+        if(++pos == this->_traceSize) pos = 0;
+    }
+    return len + 2;						// Last delta byte and value
+}
+
+/**
+ * @ingroup group03
+ * @brief Appends a bus transaction to the trace
+ * @details Encodes one record and sends it to the stream and/or the RAM ring.
+ * @param reg register (0x00 ~ 0x06)
+ * @param value register value written or read
+ * @param dir TRACE_READ or TRACE_WRITE
+ * @param status Wire endTransmission() result
+ */
+void MIC74::traceRecord(uint8_t reg, uint8_t value, uint8_t dir, uint8_t status)
+{
+    uint8_t rec[TRACE_REC_MAX], len = 0;
+    unsigned long now = micros();
+    uint32_t delta = now - this->_traceTime;
+    this->_traceTime = now;
+
+    rec[len++] = (dir << 7) | ((reg & 0x07) << 4) | ((this->_i2cAddress & 0x07) << 1) | (status != 0);
+    if(status != 0) rec[len++] = status;
+    while(delta > 0x7F)
+    {
+        rec[len++] = (delta & 0x7F) | 0x80;
+        delta >>= 7;
+    }
+    rec[len++] = delta;
+    rec[len++] = value;
+
+    if(this->_traceOut) this->_traceOut->write(rec, len);
+    if(!this->_traceBuf || len > this->_traceSize) return;
+
+    while(this->_traceSize - this->_traceUsed < len)	// Drops the oldest records to make room
+    {
+        uint8_t oldest = this->traceRecLen(this->_traceTail);
+        this->_traceTail += oldest;
+        if(this->_traceTail >= this->_traceSize) this->_traceTail -= this->_traceSize;
+        this->_traceUsed -= oldest;
+    }
+    for(uint8_t i = 0; i < len; ++i)
+    {
+        this->_traceBuf[this->_traceHead] = rec[i];
+        if(++this->_traceHead == this->_traceSize) this->_traceHead = 0;
+    }
+    this->_traceUsed += len;
 }
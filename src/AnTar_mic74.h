@@ -71,6 +71,111 @@
 
 #define IS_BIT_SET(x,y) ( (x) & (1 << (y)) )  // Check if a bit is set. Returns 0 or != 0
 
+// bus trace
+#define TRACE_READ 0x0
+#define TRACE_WRITE 0x1
+#define TRACE_NO_DATA 0x10	// Trace status of a read that received no data byte (not a Wire endTransmission() result)
+#define TRACE_REC_MAX 8		// Largest trace record in bytes
+/*	Trace record layout (one record per regRead()/regWrite() transaction):
+ *	byte 0	0bDRRRAAAS
+ *			  ^^^^^^^- S - Bus status flag (1 = a status byte follows; 0 = transaction succeeded).
+ *			  ^^^^^^-- AAA - Low three bits of the device I2C address (0x20 ~ 0x27).
+ *			  ^^^----- RRR - Register (0x00 ~ 0x06).
+ *			  ^------- D - Direction (TRACE_WRITE = 1; TRACE_READ = 0).
+ *	[status]	Wire endTransmission() result (1 ~ 5), or TRACE_NO_DATA when requestFrom() returned no byte; only present when S = 1.
+ *	delta	Microseconds since the previous record, varint (7 bits per byte, least significant group first, bit 7 = more bytes follow).
+ *			It is the 32-bit difference of micros() values, so a gap longer than 2^32 us (about 71.6 minutes) wraps and is recorded shorter.
+ *	value	Register value written or read.
+ */
+
+// bit fields
+constexpr uint8_t mic74FieldScatter(uint8_t, uint8_t) { return 0; }
+/*
+    * @brief Moves the field value bits to their pin positions
+    * @param value field value
+    * @param bit field bit placed on the first of the given pins
+    * @return port bits */
+template<typename... T>
+constexpr uint8_t mic74FieldScatter(uint8_t value, uint8_t bit, uint8_t pin, T... pins)
+{
+   return (((value >> bit) & 1) << pin) | mic74FieldScatter(value, bit + 1, pins...);
+}
+
+constexpr uint8_t mic74FieldGather(uint8_t, uint8_t) { return 0; }
+/*
+    * @brief Collects the field value bits from their pin positions
+    * @param port port bits
+    * @param bit field bit read from the first of the given pins
+    * @return field value */
+template<typename... T>
+constexpr uint8_t mic74FieldGather(uint8_t port, uint8_t bit, uint8_t pin, T... pins)
+{
+   return (((port >> pin) & 1) << bit) | mic74FieldGather(port, bit + 1, pins...);
+}
+
+constexpr bool mic74FieldPinsValid(uint8_t) { return true; }
+template<typename... T>
+constexpr bool mic74FieldPinsValid(uint8_t used, uint8_t pin, T... pins)
+{
+   return pin <= 7 && !IS_BIT_SET(used, pin) && mic74FieldPinsValid(used | (1 << pin), pins...);
+}
+
+// 16 entry table of a scatter/gather function for one nibble at a given offset
+#define MIC74_FIELD_TABLE(fn, shift) { \
+   fn(0x0 << shift, 0, Pins...), fn(0x1 << shift, 0, Pins...), fn(0x2 << shift, 0, Pins...), fn(0x3 << shift, 0, Pins...), \
+   fn(0x4 << shift, 0, Pins...), fn(0x5 << shift, 0, Pins...), fn(0x6 << shift, 0, Pins...), fn(0x7 << shift, 0, Pins...), \
+   fn(0x8 << shift, 0, Pins...), fn(0x9 << shift, 0, Pins...), fn(0xA << shift, 0, Pins...), fn(0xB << shift, 0, Pins...), \
+   fn(0xC << shift, 0, Pins...), fn(0xD << shift, 0, Pins...), fn(0xE << shift, 0, Pins...), fn(0xF << shift, 0, Pins...) }
+
+/**
+ * @brief Logical bit field made of any MIC74 pins
+ * @details The pins are listed from the least significant field bit, e.g. MIC74Field<2, 5, 6> is a 3-bit field
+ * @details with bit 0 on P2, bit 1 on P5 and bit 2 on P6. The pack/unpack tables are generated at compile time
+ * @details and kept in flash, one 16 byte table per nibble and direction.
+ */
+template<uint8_t... Pins>
+class MIC74Field
+{
+   static_assert(sizeof...(Pins) >= 1 && sizeof...(Pins) <= 8, "MIC74Field must have 1 to 8 pins");
+   static_assert(mic74FieldPinsValid(0, Pins...), "MIC74Field pins must be unique and in the range 0 to 7");
+
+   static const uint8_t _scatterLo[16];		// Port bits of the field value bits 0..3
+   static const uint8_t _scatterHi[16];		// Port bits of the field value bits 4..7
+   static const uint8_t _gatherLo[16];		// Field value bits of the port bits P0..P3
+   static const uint8_t _gatherHi[16];		// Field value bits of the port bits P4..P7
+
+public:
+   static const uint8_t mask = mic74FieldScatter(0xFF, 0, Pins...);	// Port bits used by the field
+   static const uint8_t width = sizeof...(Pins);						// Number of field bits
+
+/*
+    * @brief Converts a field value to port bits
+    * @param value field value, bits above the field width are ignored
+    * @return port bits, only the bits of mask are used */
+   
+   static inline uint8_t pack(uint8_t value)
+   {
+      return pgm_read_byte(&_scatterLo[value & 0x0F]) | pgm_read_byte(&_scatterHi[value >> 4]);
+   };
+
+/*
+    * @brief Converts port bits to a field value
+    * @param port DATA register value
+    * @return field value */
+   
+   static inline uint8_t unpack(uint8_t port)
+   {
+      return pgm_read_byte(&_gatherLo[port & 0x0F]) | pgm_read_byte(&_gatherHi[port >> 4]);
+   };
+};
+
+template<uint8_t... Pins> const uint8_t MIC74Field<Pins...>::_scatterLo[16] PROGMEM = MIC74_FIELD_TABLE(mic74FieldScatter, 0);
+template<uint8_t... Pins> const uint8_t MIC74Field<Pins...>::_scatterHi[16] PROGMEM = MIC74_FIELD_TABLE(mic74FieldScatter, 4);
+template<uint8_t... Pins> const uint8_t MIC74Field<Pins...>::_gatherLo[16] PROGMEM = MIC74_FIELD_TABLE(mic74FieldGather, 0);
+template<uint8_t... Pins> const uint8_t MIC74Field<Pins...>::_gatherHi[16] PROGMEM = MIC74_FIELD_TABLE(mic74FieldGather, 4);
+
+#undef MIC74_FIELD_TABLE
+
 class MIC74
 {
 
@@ -78,6 +183,11 @@ protected:
    uint8_t _i2cAddress = DEF_I2C_ADDR;	// Default i2c address
    uint8_t _data = PORT_SET;			// REG_DATA shadow register
    uint8_t _status = PORT_CLR;			// REG_STATUS shadow register
+   uint8_t _dir = PORT_CLR;				// REG_DIR shadow register
+   uint8_t _outCfg = PORT_CLR;			// REG_OUT_CFG shadow register
+   uint8_t _intMask = PORT_CLR;			// REG_INT_MASK shadow register
+   uint8_t _latchLow = PORT_CLR;		// Pins whose DATA output latch is known to hold 0
+   uint8_t _latchMayLow = PORT_CLR;		// Pins whose DATA output latch may hold 0 (power-on latch is 0xFF)
 
    uint8_t regRead(uint8_t reg);								// Gets the given register information
    void regWrite(uint8_t reg, uint8_t value);					// Sets a value to a given register
@@ -85,8 +195,20 @@ protected:
    bool regBitRead(uint8_t mic_register, uint8_t bit_position);
    void regBitWrite(uint8_t mic_register, uint8_t bit_position, uint8_t value);
 
+   uint8_t *_traceBuf = NULL;			// Bus trace RAM ring (NULL = not recording to RAM)
+   uint16_t _traceSize = 0;				// Bus trace RAM ring size in bytes
+   uint16_t _traceHead = 0;				// Ring offset where the next record starts
+   uint16_t _traceTail = 0;				// Ring offset of the oldest record
+   uint16_t _traceUsed = 0;				// Number of bytes held in the ring
+   Print *_traceOut = NULL;				// Bus trace stream (NULL = not streaming)
+   unsigned long _traceTime = 0;		// micros() of the previous trace record
+
+   void traceRecord(uint8_t reg, uint8_t value, uint8_t dir, uint8_t status);	// Appends a bus transaction to the trace
+   uint8_t traceRecLen(uint16_t pos);							// Gets the length of the ring record at a given offset
+
 public:
    void begin(uint8_t i2cAddress = DEF_I2C_ADDR, long i2cFrequency = DEF_I2C_FREQ);
+   void syncShadows();										// Reads DIR, OUT_CFG, INT_MASK and DATA into the shadow registers
 
    void setup(uint8_t ie = OFF, uint8_t fan = OFF);			// Sets the DEV_CFG register
 
@@ -96,6 +218,10 @@ public:
    void writePortMode(uint8_t value);						// Sets a value to the DIR Register
 
    void pinMode(uint8_t pin, uint8_t mode);					// Configures the specified pin to behave either as an input or an output
+   void switchPinMode(uint8_t pin, uint8_t mode);			// Changes the pin mode from the shadow registers, keeping the output level
+   void switchPinMode(uint8_t pin, uint8_t mode, uint8_t value);	// Changes the pin mode from the shadow registers with a given output level
+   void pinRelease(uint8_t pin);							// Open-drain release: turns a given pin to input with a single DIR write
+   void pinDriveLow(uint8_t pin);							// Open-drain drive low: turns a given pin to output with a single DIR write
 
    uint8_t readPortOutMode();								// Gets a value from the OUT_CFG Register
    void writePortOutMode(uint8_t value);					// Sets a value to the OUT_CFG Register
@@ -115,6 +241,7 @@ public:
    uint8_t portRead();										// Reads the value from the MIC74 entire GPIO, from 0 to 255
    void portWrite();										// Sets a value to the GPIO Register
    void portWrite(uint8_t value);							// Sets a value to the GPIO Register
+   void portWrite(uint8_t value, uint8_t mask);				// Sets the masked bits of the GPIO Register from the shadow register
 
    uint8_t digitalRead(uint8_t pin);						// Reads the value from a specified MIC74 pin, either HIGH or LOW
    void digitalWrite(uint8_t pin, uint8_t value);			// Sets a given value to a given GPIO pin
@@ -130,6 +257,50 @@ public:
 
    uint8_t readStatus();									// Gets the current STATUS register value
 
+/*
+    * @ingroup group02
+    * @brief Writes a value to a logical bit field
+    * @details All field pins change with a single DATA write built from the shadow register, so the field never passes through intermediate values.
+    * @details Call portRead() once beforehand if the shadow register may not match the chip.
+    * @param value field value
+    * Example: mic.fieldWrite<MIC74Field<2, 5, 6>>(5); */
+   
+   template<class Field>
+   inline void fieldWrite(uint8_t value)
+   {
+      this->portWrite(Field::pack(value), Field::mask);
+   };
+
+/*
+    * @ingroup group02
+    * @brief Writes a value to a logical bit field delayed
+    * @details It is just write the field to the shadow register and do not send it to the chip
+    * @param value field value */
+   
+   template<class Field>
+   inline void fieldWriteDelayed(uint8_t value)
+   {
+      this->_data = (this->_data & ~Field::mask) | Field::pack(value);
+   };
+
+/*
+    * @ingroup group02
+    * @brief Reads a logical bit field
+    * @details All field pins are sampled with a single DATA read
+    * @return field value */
+   
+   template<class Field>
+   inline uint8_t fieldRead()
+   {
+      return Field::unpack(this->portRead());
+   };
+
+   void traceBegin(uint8_t *buffer, uint16_t size);			// Starts recording bus transactions to a RAM ring
+   void traceBegin(Print &out);								// Starts streaming bus transactions to a Print (e.g. Serial)
+   void traceEnd();											// Stops recording bus transactions
+   uint16_t traceAvailable();								// Gets the number of bytes held in the trace ring
+   uint16_t traceDump(Print &out);							// Writes the trace ring oldest first and empties it
+
 /*
     * @ingroup group01
     * @brief Just view STATUS shadow register